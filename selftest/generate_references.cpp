@@ -0,0 +1,274 @@
+// Writes the --selftest reference files from the original fixed-function renderer.
+//
+// BASELINE_SOURCE is that renderer's testGrafica1.cpp: the first commit of the repository, with an
+// empty windows.h on the include path (CMakeLists.txt, target selftest_references). It is compiled
+// in here with glut stubbed out and glBegin/glNormal3f/glVertex3f/glEnd hooked, drawn into an FBO
+// of a surfaceless EGL context.
+//
+//   generate_references <output directory>
+//
+// view_<rotX>_<rotY>.rgba: the baseline frame at that rotation. Alpha is the pixel class:
+//   0   line layer: pixels a line primitive changes (axes, base outline, interior GL_LINE pass)
+//       and the interior that pass is drawn over (the back faces filled instead of outlined)
+//   128 arrow heads: pixels the three glutSolidCone calls change
+//   255 everything else (lit surfaces, background)
+// cone_*.vtx: the geometry the old drawBezierCone emitted (format in README.md).
+#define GL_GLEXT_PROTOTYPES 1
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/freeglut.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// --- glut: no window; glutSolidCone emits freeglut's vertices and normals (fghGenerateCone) ---
+extern "C" {
+void glutInit(int*, char**) {}
+void glutInitWindowPosition(int, int) {}
+void glutInitWindowSize(int, int) {}
+void glutInitDisplayMode(unsigned int) {}
+int  glutCreateWindow(const char*) { return 1; }
+void glutDisplayFunc(void (*)(void)) {}
+void glutIdleFunc(void (*)(void)) {}
+void glutReshapeFunc(void (*)(int, int)) {}
+void glutMouseFunc(void (*)(int, int, int, int)) {}
+void glutMotionFunc(void (*)(int, int)) {}
+void glutSpecialFunc(void (*)(int, int, int)) {}
+void glutKeyboardFunc(void (*)(unsigned char, int, int)) {}
+void glutPostRedisplay(void) {}
+void glutSwapBuffers(void) {}
+void glutMainLoop(void) {}
+
+static bool g_noArrows = false;   // glutSolidCone draws nothing
+
+void glutSolidCone(double base, double height, GLint slices, GLint stacks) {
+    if (g_noArrows) return;
+    double zStep = height / stacks, rStep = base / stacks;
+    double len = std::sqrt(height * height + base * base);
+    double cosn = height / len, sinn = base / len;
+    std::vector<double> c(slices + 1), s(slices + 1);
+    for (int j = 0; j <= slices; ++j) {
+        double a = -2.0 * M_PI * j / slices;   // freeglut walks the circle clockwise
+        c[j] = std::cos(a);
+        s[j] = std::sin(a);
+    }
+    glBegin(GL_TRIANGLE_FAN);
+    glNormal3d(0, 0, -1);
+    glVertex3d(0, 0, 0);
+    for (int j = 0; j <= slices; ++j) glVertex3d(c[j] * base, s[j] * base, 0);
+    glEnd();
+    double z0 = 0, r0 = base;
+    for (int i = 0; i < stacks; ++i) {
+        double z1 = z0 + zStep, r1 = r0 - rStep;
+        glBegin(GL_QUAD_STRIP);
+        for (int j = 0; j <= slices; ++j) {
+            glNormal3d(c[j] * cosn, s[j] * cosn, sinn);
+            glVertex3d(c[j] * r1, s[j] * r1, z1);
+            glVertex3d(c[j] * r0, s[j] * r0, z0);
+        }
+        glEnd();
+        z0 = z1;
+        r0 = r1;
+    }
+}
+}
+
+// --- Immediate-mode hooks: capture the cone's vertices, or leave out the line primitives ---
+struct Captured { float pos[3], normal[3]; };
+static bool g_capture = false;                 // record instead of drawing
+static bool g_noLines = false;                 // draw everything except line primitives
+static bool g_fillInterior = false;            // the interior pass fills its back faces
+static bool g_skipping = false;
+static bool g_filling = false;
+static std::vector<std::vector<Captured>> g_batches;
+static float g_normal[3];
+
+static void hookBegin(GLenum mode) {
+    if (g_capture) { g_batches.emplace_back(); return; }
+    GLint polygonMode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);   // the interior pass is GL_LINE on back faces
+    g_filling = g_fillInterior && polygonMode[1] == GL_LINE;
+    g_skipping = g_noLines && !g_filling && (mode == GL_LINES || mode == GL_LINE_LOOP ||
+                                             mode == GL_LINE_STRIP || polygonMode[1] == GL_LINE);
+    if (g_filling) glPolygonMode(GL_BACK, GL_FILL);
+    if (!g_skipping) glBegin(mode);
+}
+static void hookNormal(GLfloat x, GLfloat y, GLfloat z) {
+    g_normal[0] = x; g_normal[1] = y; g_normal[2] = z;
+    if (!g_capture && !g_skipping) glNormal3f(x, y, z);
+}
+static void hookVertex(GLfloat x, GLfloat y, GLfloat z) {
+    if (g_capture) g_batches.back().push_back({ { x, y, z }, { g_normal[0], g_normal[1], g_normal[2] } });
+    else if (!g_skipping) glVertex3f(x, y, z);
+}
+static void hookEnd() {
+    if (!g_capture && !g_skipping) glEnd();
+    if (g_filling) glPolygonMode(GL_BACK, GL_LINE);
+    g_skipping = false;
+    g_filling = false;
+}
+
+#define glBegin hookBegin
+#define glNormal3f hookNormal
+#define glVertex3f hookVertex
+#define glEnd hookEnd
+#define main baselineMain
+#include BASELINE_SOURCE
+#undef main
+#undef glBegin
+#undef glNormal3f
+#undef glVertex3f
+#undef glEnd
+
+static const int kSize = 276;   // runSelfTest's offscreen target
+
+static void putU32(FILE* f, uint32_t v) { std::fwrite(&v, 4, 1, f); }
+template <typename T>
+static void putArray(FILE* f, const std::vector<T>& v) {
+    putU32(f, (uint32_t)v.size());
+    std::fwrite(v.data(), sizeof(T), v.size(), f);
+}
+
+// Batches of one drawBezierCone call: lit triangles, GL_LINE pass, outline
+static bool writeDump(const std::string& path, float L, int samples, float innerR, float outerR,
+                      float sweepDeg, int layers, int sectors) {
+    g_batches.clear();
+    g_capture = true;
+    drawBezierCone(L, samples, innerR, outerR, sweepDeg, layers, sectors, +1);
+    g_capture = false;
+    if (g_batches.size() != 3) return false;
+
+    std::vector<Point> petal = generatePetal(L, samples, innerR, outerR, sweepDeg);
+    std::vector<Point> loop;
+    for (int k = 0; k < 4; ++k) {
+        std::vector<Point> r = rotatePetal(petal, k * 90.0f);
+        loop.insert(loop.end(), r.begin(), r.end());
+    }
+    if (sectors > 0) loop = resampleClosedLoop(loop, sectors);
+    std::vector<Point> outline;
+    for (const Captured& v : g_batches[2]) outline.push_back({ v.pos[0], v.pos[1], v.pos[2] });
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fwrite("VTXD", 1, 4, f);
+    putU32(f, 1);
+    // ConeParams: L, samples, innerR, outerR, sweepDeg, layers, sectors
+    std::fwrite(&L, 4, 1, f); std::fwrite(&samples, 4, 1, f);
+    std::fwrite(&innerR, 4, 1, f); std::fwrite(&outerR, 4, 1, f); std::fwrite(&sweepDeg, 4, 1, f);
+    std::fwrite(&layers, 4, 1, f); std::fwrite(&sectors, 4, 1, f);
+    putArray(f, petal);
+    putArray(f, loop);
+    putArray(f, g_batches[0]);
+    putArray(f, outline);
+    bool ok = std::fclose(f) == 0;
+    std::printf("%s: %zu triangle vertices, %zu outline points\n", path.c_str(), g_batches[0].size(), outline.size());
+    return ok;
+}
+
+static std::vector<unsigned char> readFrame() {
+    std::vector<unsigned char> px((size_t)kSize * kSize * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, kSize, kSize, GL_RGBA, GL_UNSIGNED_BYTE, px.data());
+    return px;
+}
+
+static bool differs(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, size_t i) {
+    return a[i] != b[i] || a[i + 1] != b[i + 1] || a[i + 2] != b[i + 2];
+}
+
+static bool writeView(const std::string& dir, float rotX, float rotY) {
+    g_rotX = rotX;
+    g_rotY = rotY;
+    resize(kSize, kSize);
+    g_noLines = true;
+    display();
+    std::vector<unsigned char> fill = readFrame();
+    g_fillInterior = true;
+    display();
+    std::vector<unsigned char> interior = readFrame();
+    g_noLines = g_fillInterior = false;
+    g_noArrows = true;
+    display();
+    std::vector<unsigned char> noArrows = readFrame();
+    g_noArrows = false;
+    display();
+    std::vector<unsigned char> px = readFrame();
+    size_t lines = 0, arrows = 0;
+    for (size_t i = 0; i < px.size(); i += 4) {
+        if (differs(px, fill, i) || differs(interior, fill, i)) {
+            px[i + 3] = 0;
+            ++lines;
+        } else if (differs(px, noArrows, i)) {
+            px[i + 3] = 128;
+            ++arrows;
+        } else {
+            px[i + 3] = 255;
+        }
+    }
+    char name[64];
+    std::snprintf(name, sizeof(name), "/view_%g_%g.rgba", rotX, rotY);
+    FILE* f = std::fopen((dir + name).c_str(), "wb");
+    if (!f) return false;
+    std::fwrite(px.data(), 1, px.size(), f);
+    bool ok = std::fclose(f) == 0;
+    std::printf("%s: %zu line layer pixels, %zu arrow head pixels\n", name + 1, lines, arrows);
+    return ok;
+}
+
+static bool createContext() {
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy = getPlatformDisplay
+        ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+        : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)) return false;
+    const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    eglChooseConfig(dpy, configAttribs, &config, 1, &configs);
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_NONE };
+    EGLContext ctx = eglCreateContext(dpy, configs ? config : (EGLConfig)nullptr, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) return false;
+
+    GLuint fbo, rb[2];
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(2, rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, rb[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, kSize, kSize);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, rb[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, kSize, kSize);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb[1]);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <output directory>\n", argv[0]);
+        return 2;
+    }
+    if (!createContext()) {
+        std::fprintf(stderr, "cannot create a surfaceless GL 3.3 compatibility context\n");
+        return 1;
+    }
+    baselineMain();   // lights, material, clear color; glutMainLoop() returns at once
+
+    const std::string dir = argv[1];
+    // Same views and cones as runSelfTest()
+    const float views[][2] = { { 0.f, 0.f }, { -60.f, 120.f }, { -60.f, -60.f } };
+    bool ok = true;
+    for (const auto& v : views) ok = writeView(dir, v[0], v[1]) && ok;
+    ok = writeDump(dir + "/cone_display.vtx", 3.0f, 60, 0.5f, 2.5f, 0.0f, 7, 96) && ok;
+    ok = writeDump(dir + "/cone_raw_sweep.vtx", 3.0f, 24, 0.4f, 2.4f, 20.0f, 5, 0) && ok;
+    if (glGetError() != GL_NO_ERROR) ok = false;
+    return ok ? 0 : 1;
+}
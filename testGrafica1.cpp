@@ -1,6 +1,25 @@
-﻿#include <windows.h>
+﻿#ifdef _WIN32
+#define NOMINMAX   // std::max/std::min below; windows.h would make them macros
+#include <windows.h>
+#include <GL/glew.h>
+#else
+#define GL_GLEXT_PROTOTYPES 1   // libGL exports the GL 3.3 entry points; no loader needed
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 #include <GL/freeglut.h>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifndef M_PI
@@ -16,6 +35,54 @@ static float g_rotX = 0.0f, g_rotY = 0.0f;
 static bool  g_dragging = false;
 static int   g_lastX = 0, g_lastY = 0;
 static float g_sensitivity = 0.5f;
+static bool  g_gpuConeMode = false;   // G: evaluate the cone in the vertex shader
+static bool  g_compactMode = false;   // C: 8-byte quantized vertices for the CPU-built mesh
+static bool  g_exportMesh = false;    // E: write the scene cone to con.cmsh (handled in display())
+
+// --- Frame instrumentation (shown in the window title) ---
+struct FrameStats {
+    int drawCalls = 0;      // glDraw* calls this frame
+    int stateChanges = 0;   // program/VAO binds and fixed state that actually changed (BoundState)
+    int frames = 0;         // since the last report
+    int lastReportMs = 0;
+    double sumDraws = 0, sumStates = 0;
+};
+static FrameStats g_frameStats;
+static void countDraw() { ++g_frameStats.drawCalls; }
+static void countState(int n = 1) { g_frameStats.stateChanges += n; }
+
+// Program, VAO, front face and line width go through these: a call that would not change the
+// current value is skipped and not counted, so the title shows real changes, not calls
+struct BoundState {
+    GLuint  program = 0, vao = 0;
+    GLenum  frontFace = GL_CCW;
+    GLfloat lineWidth = 1.0f;
+};
+static BoundState g_bound;
+static void useProgram(GLuint id) {
+    if (id == g_bound.program) return;
+    glUseProgram(id);
+    g_bound.program = id;
+    countState();
+}
+static void bindVertexArray(GLuint vao) {
+    if (vao == g_bound.vao) return;
+    glBindVertexArray(vao);
+    g_bound.vao = vao;
+    countState();
+}
+static void setFrontFace(GLenum mode) {
+    if (mode == g_bound.frontFace) return;
+    glFrontFace(mode);
+    g_bound.frontFace = mode;
+    countState();
+}
+static void setLineWidth(GLfloat width) {
+    if (width == g_bound.lineWidth) return;
+    glLineWidth(width);
+    g_bound.lineWidth = width;
+    countState();
+}
 
 // Mouse button callback
 void OnMouseButton(int button, int state, int x, int y) {
@@ -49,6 +116,9 @@ void OnSpecialKey(int key, int, int) {
 }
 void OnKeyboard(unsigned char key, int, int) {
     if (key == 'r' || key == 'R') { g_rotX = g_rotY = 0.0f; glutPostRedisplay(); }
+    if (key == 'g' || key == 'G') { g_gpuConeMode = !g_gpuConeMode; glutPostRedisplay(); }
+    if (key == 'c' || key == 'C') { g_compactMode = !g_compactMode; glutPostRedisplay(); }
+    if (key == 'e' || key == 'E') { g_exportMesh = true; glutPostRedisplay(); }
 }
 
 // Funcție pentru evaluarea unei curbe Bézier cubice
@@ -65,27 +135,33 @@ Point bezier(const Point& p0, const Point& p1, const Point& p2, const Point& p3,
     };
 }
 
-// Generează o petală Bézier în planul YZ (la x = L)
+// Punctele de control ale unei petale Bézier în planul YZ (la x = L)
 // innerR = distanța minimă față de axa X (offsetul dorit)
 // outerR = cât de mult iese petala în exterior (bombare)
 // sweepDeg = un mic unghi astfel încât p0 și p3 să fie pe un cerc de rază innerR la unghiuri diferite (opțional)
-std::vector<Point> generatePetal(float L, int samples, float innerR, float outerR, float sweepDeg = 0.0f) {
+void petalControlPoints(float L, float innerR, float outerR, float sweepDeg, Point ctrl[4]) {
     float sweep = sweepDeg * (float)M_PI / 180.0f;
 
     // Punctele de start/finish pe cercul de rază innerR în planul YZ
     // p0 la unghi -sweep/2, p3 la +sweep/2 în jurul +Z (y=sin, z=cos)
-    Point p0 = { L, innerR * std::sin(-0.5f * sweep), innerR * std::cos(-0.5f * sweep) };
-    Point p3 = { L, innerR * std::sin(+0.5f * sweep), innerR * std::cos(+0.5f * sweep) };
+    ctrl[0] = { L, innerR * std::sin(-0.5f * sweep), innerR * std::cos(-0.5f * sweep) };
+    ctrl[3] = { L, innerR * std::sin(+0.5f * sweep), innerR * std::cos(+0.5f * sweep) };
 
     // Puncte de control pentru bombare (simetrice pe Y, împinse pe +Z la outerR)
-    Point p1 = { L, +0.6f * outerR, outerR };
-    Point p2 = { L, -0.6f * outerR, outerR };
+    ctrl[1] = { L, +0.6f * outerR, outerR };
+    ctrl[2] = { L, -0.6f * outerR, outerR };
+}
+
+// Generează o petală Bézier (samples + 1 puncte) în planul YZ (la x = L)
+std::vector<Point> generatePetal(float L, int samples, float innerR, float outerR, float sweepDeg = 0.0f) {
+    Point ctrl[4];
+    petalControlPoints(L, innerR, outerR, sweepDeg, ctrl);
 
     std::vector<Point> curve;
     curve.reserve(static_cast<size_t>(samples) + 1);
     for (int i = 0; i <= samples; i++) {
         float t = (float)i / samples;
-        curve.push_back(bezier(p0, p1, p2, p3, t));
+        curve.push_back(bezier(ctrl[0], ctrl[1], ctrl[2], ctrl[3], t));
     }
     return curve;
 }
@@ -148,9 +224,331 @@ static std::vector<Point> resampleClosedLoop(const std::vector<Point>& loop, int
     return out;
 }
 
-// Modify the signature to add 'sectors' (last arg). Keep default as -1 to preserve current behavior.
-void drawBezierCone(float L = 3.0f, int samples = 50, float innerR = 0.4f, float outerR = 2.4f,
-                    float sweepDeg = 0.0f, int layers = -1, int sectors = -1, int windingSign = +1) {
+// --- Lumina și materialul (aceleași valori ca înainte, folosite acum de shader) ---
+static const GLfloat kLightPos[]      = { 5.0f, 8.0f, 7.0f, 1.0f };  // eye space
+static const GLfloat kLightAmbient[]  = { 0.25f, 0.25f, 0.25f, 1.0f };
+static const GLfloat kLightDiffuse[]  = { 0.95f, 0.95f, 0.95f, 1.0f };
+static const GLfloat kLightSpecular[] = { 0.85f, 0.85f, 0.85f, 1.0f };
+static const GLfloat kSceneAmbient[]  = { 0.2f, 0.2f, 0.2f, 1.0f };    // GL_LIGHT_MODEL_AMBIENT default
+static const GLfloat kMatSpecular[]   = { 0.5f, 0.5f, 0.5f, 1.0f };
+static const GLfloat kMatShininess    = 32.0f;
+
+// Per-pixel Blinn-Phong for the exterior, barycentric wireframe for the interior.
+// Triangles are non-indexed, so the corner of each vertex is gl_VertexID % 3.
+static const char* kConeVS = R"(#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+uniform mat4 uModelView;
+uniform mat4 uProjection;
+uniform vec3 uColor;
+uniform int  uCompact;     // 1: aPos = 16-bit box coordinates, aNormal.xy = octahedral * 127
+uniform vec3 uPosOffset;
+uniform vec3 uPosScale;
+out vec3 vEyePos;
+out vec3 vEyeNormal;
+noperspective out vec3 vBary;
+out vec3 vColor;
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+void main() {
+    vec3 pos = uCompact != 0 ? uPosOffset + aPos * uPosScale : aPos;
+    vec3 normal = uCompact != 0 ? octDecode(aNormal.xy / 127.0) : aNormal;
+    vec4 eye = uModelView * vec4(pos, 1.0);
+    vEyePos = eye.xyz;
+    // modelview is rotations/translations plus the mirror scale, so mat3() is orthogonal
+    vEyeNormal = mat3(uModelView) * normal;
+    int corner = gl_VertexID % 3;
+    vBary = vec3(corner == 0, corner == 1, corner == 2);
+    vColor = uColor;
+    gl_Position = uProjection * eye;
+}
+)";
+
+static const char* kConeFS = R"(#version 330 core
+in vec3 vEyePos;
+in vec3 vEyeNormal;
+noperspective in vec3 vBary;
+in vec3 vColor;
+uniform int   uUnlit;
+uniform int   uWire;       // 0: back faces are dropped instead of drawn as edges
+uniform vec4  uLightPos;
+uniform vec3  uLightAmbient;
+uniform vec3  uLightDiffuse;
+uniform vec3  uLightSpecular;
+uniform vec3  uSceneAmbient;
+uniform vec3  uMatSpecular;
+uniform float uShininess;
+uniform vec4  uWireColor;
+uniform float uWireWidth;
+out vec4 fragColor;
+void main() {
+    if (uUnlit != 0) { fragColor = vec4(vColor, 1.0); return; }
+
+    if (!gl_FrontFacing) {
+        if (uWire == 0) discard;
+        // Interior: keep only the triangle edges (each side contributes half the width)
+        vec3 a = smoothstep(vec3(0.0), fwidth(vBary) * (0.5 * uWireWidth), vBary);
+        float edge = 1.0 - min(min(a.x, a.y), a.z);
+        if (edge <= 0.0) discard;
+        fragColor = vec4(uWireColor.rgb, uWireColor.a * edge);
+        return;
+    }
+
+    vec3 N = normalize(vEyeNormal);
+    vec3 L = normalize(uLightPos.xyz - vEyePos * uLightPos.w);
+    vec3 H = normalize(L + vec3(0.0, 0.0, 1.0));   // infinite viewer, like the fixed pipeline
+    float nDotL = max(dot(N, L), 0.0);
+    float spec  = nDotL > 0.0 ? pow(max(dot(N, H), 0.0), uShininess) : 0.0;
+    vec3 c = (uSceneAmbient + uLightAmbient + nDotL * uLightDiffuse) * vColor
+           + spec * uLightSpecular * uMatSpecular;
+    fragColor = vec4(min(c, vec3(1.0)), 1.0);
+}
+)";
+
+// Same cone, evaluated in the vertex shader from the petal control points (no vertex buffer).
+// gl_VertexID -> (layer, sector, corner) in the same order as buildBezierCone.
+static const char* kConeGpuVS = R"(#version 330 core
+layout(std140) uniform ConeParams {
+    vec4  uCtrl[4];   // control points of petal 0 (xyz)
+    ivec4 uGrid;      // layers, sectors, samples, resample (1 = by arc length, like resampleClosedLoop)
+    vec4  uArc;       // petal length, chord to the next petal, their sum
+};
+uniform mat4 uModelView;
+uniform mat4 uProjection;
+uniform int  uOutline;   // 1: base outline, one vertex per sector on the last ring
+uniform vec3 uColor;
+out vec3 vEyePos;
+out vec3 vEyeNormal;
+noperspective out vec3 vBary;
+out vec3 vColor;
+out vec3 vObjPos;        // object space, read back by verifyGpuCone()
+out vec3 vObjNormal;
+
+const int   kPetals = 4;
+const float kPetalAngle = 1.5707963268;
+
+vec3 rotX(vec3 p, float a) {
+    float c = cos(a), s = sin(a);
+    return vec3(p.x, p.y * c - p.z * s, p.y * s + p.z * c);
+}
+vec3 bez(float t) {
+    float u = 1.0 - t;
+    return u * u * u * uCtrl[0].xyz + 3.0 * u * u * t * uCtrl[1].xyz
+         + 3.0 * u * t * t * uCtrl[2].xyz + t * t * t * uCtrl[3].xyz;
+}
+vec3 bezD(float t) {
+    float u = 1.0 - t;
+    return 3.0 * (u * u * (uCtrl[1].xyz - uCtrl[0].xyz) + 2.0 * u * t * (uCtrl[2].xyz - uCtrl[1].xyz)
+                + t * t * (uCtrl[3].xyz - uCtrl[2].xyz));
+}
+// Arc length on [0, t]; must stay identical to petalArcLength() on the CPU
+float arcLen(float t) {
+    const float x[5] = float[](-0.9061798459, -0.5384693101, 0.0, 0.5384693101, 0.9061798459);
+    const float w[5] = float[](0.2369268851, 0.4786286705, 0.5688888889, 0.4786286705, 0.2369268851);
+    float h = 0.25 * t, sum = 0.0;
+    for (int k = 0; k < 4; ++k)
+        for (int j = 0; j < 5; ++j)
+            sum += w[j] * length(bezD(h * (float(k) + 0.5 * (x[j] + 1.0))));
+    return 0.5 * h * sum;
+}
+// Bezier parameter at arc length s (Newton)
+float paramAtLength(float s) {
+    float t = s / uArc.x;
+    for (int it = 0; it < 5; ++it)
+        t = clamp(t - (arcLen(t) - s) / max(length(bezD(t)), 1e-6), 0.0, 1.0);
+    return t;
+}
+// Point on the closed base loop and its direction of travel
+void basePoint(int i, out vec3 p, out vec3 d) {
+    int k;
+    vec3 q;
+    if (uGrid.w != 0) {
+        float s = uArc.z * float(kPetals) * float(i) / float(uGrid.y);
+        k = min(int(s / uArc.z), kPetals - 1);
+        float sl = s - float(k) * uArc.z;
+        if (sl < uArc.x || uArc.y <= 0.0) {
+            float t = paramAtLength(min(sl, uArc.x));
+            q = bez(t);
+            d = bezD(t);
+        } else {
+            vec3 next = rotX(uCtrl[0].xyz, kPetalAngle);
+            q = mix(uCtrl[3].xyz, next, (sl - uArc.x) / uArc.y);
+            d = next - uCtrl[3].xyz;
+        }
+    } else {
+        int n = uGrid.z + 1;   // raw generatePetal samples, petal after petal
+        k = i / n;
+        float t = float(i - k * n) / float(uGrid.z);
+        q = bez(t);
+        d = bezD(t);
+    }
+    p = rotX(q, float(k) * kPetalAngle);
+    d = rotX(d, float(k) * kPetalAngle);
+}
+void main() {
+    int layers = uGrid.x, sectors = uGrid.y;
+    int r, i;
+    if (uOutline != 0) {
+        r = layers;
+        i = gl_VertexID;
+    } else {
+        // v00 v10 v11 | v00 v11 v01
+        const int dr[6] = int[](0, 1, 1, 0, 1, 0);
+        const int di[6] = int[](0, 0, 1, 0, 1, 1);
+        int quad = gl_VertexID / 6, corner = gl_VertexID % 6;
+        r = quad / sectors + dr[corner];
+        i = (quad % sectors + di[corner]) % sectors;
+    }
+    vec3 b, d;
+    basePoint(i, b, d);
+    // P(s, u) = s * B(u): the normal B x B' is the same along the whole ruling
+    vObjPos = b * (float(r) / float(layers));
+    vObjNormal = normalize(cross(b, d));
+
+    vec4 eye = uModelView * vec4(vObjPos, 1.0);
+    vEyePos = eye.xyz;
+    vEyeNormal = mat3(uModelView) * vObjNormal;
+    int c = gl_VertexID % 3;
+    vBary = vec3(c == 0, c == 1, c == 2);
+    vColor = uColor;
+    gl_Position = uProjection * eye;
+}
+)";
+
+// Static helpers (axes, arrow heads): one shared mesh, color and transform per instance
+static const char* kSceneVS = R"(#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec3 aColor;   // per instance
+layout(location = 3) in mat4 aModel;   // per instance, locations 3..6
+uniform mat4 uModelView;
+uniform mat4 uProjection;
+out vec3 vEyePos;
+out vec3 vEyeNormal;
+noperspective out vec3 vBary;
+out vec3 vColor;
+void main() {
+    mat4 mv = uModelView * aModel;
+    vec4 eye = mv * vec4(aPos, 1.0);
+    vEyePos = eye.xyz;
+    vEyeNormal = mat3(mv) * aNormal;
+    vBary = vec3(1.0);   // unused: the scene program runs with uWire = 0
+    vColor = aColor;
+    gl_Position = uProjection * eye;
+}
+)";
+
+static GLuint compileShader(GLenum type, const char* src) {
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, nullptr);
+    glCompileShader(sh);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(sh, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "shader compile error:\n%s\n", log);
+        glDeleteShader(sh);
+        return 0;
+    }
+    return sh;
+}
+
+// 'varyings' (optional) are captured interleaved by transform feedback. Returns 0 on failure.
+static GLuint linkProgram(const char* vs, const char* fs,
+                          const char* const* varyings = nullptr, int varyingCount = 0) {
+    GLuint v = compileShader(GL_VERTEX_SHADER, vs);
+    GLuint f = compileShader(GL_FRAGMENT_SHADER, fs);
+    if (!v || !f) {
+        glDeleteShader(v);
+        glDeleteShader(f);
+        return 0;
+    }
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, v);
+    glAttachShader(prog, f);
+    if (varyingCount > 0)
+        glTransformFeedbackVaryings(prog, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(prog);
+    glDeleteShader(v);
+    glDeleteShader(f);
+    GLint ok = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(prog, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "program link error:\n%s\n", log);
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+// Uploads the current fixed-function matrices, so callers keep using glTranslate/glRotate
+static void uploadMatrices(GLint locModelView, GLint locProjection) {
+    GLfloat m[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, m);
+    glUniformMatrix4fv(locModelView, 1, GL_FALSE, m);
+    glGetFloatv(GL_PROJECTION_MATRIX, m);
+    glUniformMatrix4fv(locProjection, 1, GL_FALSE, m);
+}
+
+struct ConeProgram {
+    GLuint id = 0;
+    GLint uModelView = -1, uProjection = -1, uUnlit = -1, uColor = -1;
+    GLint uOutline = -1;   // kConeGpuVS only (-1 is ignored by glUniform)
+    GLint uCompact = -1, uPosOffset = -1, uPosScale = -1;   // kConeVS only
+};
+static ConeProgram g_coneProg;     // CPU-built mesh from a VBO
+static ConeProgram g_coneGpuProg;  // mesh evaluated in the vertex shader (kConeGpuVS)
+
+static void initConeProgram(ConeProgram& p, GLuint id, bool wire = true) {
+    p.id = id;
+    if (!id) return;
+    p.uModelView  = glGetUniformLocation(p.id, "uModelView");
+    p.uProjection = glGetUniformLocation(p.id, "uProjection");
+    p.uUnlit      = glGetUniformLocation(p.id, "uUnlit");
+    p.uColor      = glGetUniformLocation(p.id, "uColor");
+    p.uOutline    = glGetUniformLocation(p.id, "uOutline");
+    p.uCompact    = glGetUniformLocation(p.id, "uCompact");
+    p.uPosOffset  = glGetUniformLocation(p.id, "uPosOffset");
+    p.uPosScale   = glGetUniformLocation(p.id, "uPosScale");
+
+    GLuint block = glGetUniformBlockIndex(p.id, "ConeParams");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(p.id, block, 0);
+
+    // Constant uniforms: set once, they live in the program object
+    useProgram(p.id);
+    glUniform4fv(glGetUniformLocation(p.id, "uLightPos"), 1, kLightPos);
+    glUniform3fv(glGetUniformLocation(p.id, "uLightAmbient"), 1, kLightAmbient);
+    glUniform3fv(glGetUniformLocation(p.id, "uLightDiffuse"), 1, kLightDiffuse);
+    glUniform3fv(glGetUniformLocation(p.id, "uLightSpecular"), 1, kLightSpecular);
+    glUniform3fv(glGetUniformLocation(p.id, "uSceneAmbient"), 1, kSceneAmbient);
+    glUniform3fv(glGetUniformLocation(p.id, "uMatSpecular"), 1, kMatSpecular);
+    glUniform1f(glGetUniformLocation(p.id, "uShininess"), kMatShininess);
+    glUniform4f(glGetUniformLocation(p.id, "uWireColor"), 0.f, 0.f, 0.f, 0.35f);
+    glUniform1f(glGetUniformLocation(p.id, "uWireWidth"), 1.2f);
+    glUniform1i(glGetUniformLocation(p.id, "uWire"), wire ? 1 : 0);
+    useProgram(0);
+}
+
+struct Vertex {
+    Point pos;
+    Point normal;
+};
+
+// Triangle list (lit exterior + wire interior) followed by the base outline (line loop)
+struct ConeMesh {
+    std::vector<Vertex> verts;
+    int triVerts = 0;
+    int loopVerts = 0;
+};
+
+ConeMesh buildBezierCone(float L, int samples, float innerR, float outerR,
+                         float sweepDeg, int layers, int sectors) {
     if (layers < 0) layers = samples;
 
     // Baza (curbă inițială)
@@ -211,84 +609,646 @@ void drawBezierCone(float L = 3.0f, int samples = 50, float innerR = 0.4f, float
         }
     }
 
-    // Adjust front-face depending on mirror parity
-    glEnable(GL_CULL_FACE);
-    glFrontFace(windingSign < 0 ? GL_CCW : GL_CW);
-
-    // PASS 1: Exterior neted (front faces only)
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT, GL_FILL);
-    glColor3d(0.7, 0.2, 0.8);
-    glBegin(GL_TRIANGLES);
+    ConeMesh mesh;
+    mesh.verts.reserve((size_t)layers * sectors * 6 + sectors);
     for (int r = 0; r < layers; ++r) {
         for (int i = 0; i < sectors; ++i) {
             int inext = (i + 1) % sectors;
-            const Point& v00 = rings[r][i];
-            const Point& v01 = rings[r][inext];
-            const Point& v10 = rings[r + 1][i];
-            const Point& v11 = rings[r + 1][inext];
+            Vertex v00{ rings[r][i],             normalize(vnorm[r][i]) };
+            Vertex v01{ rings[r][inext],         normalize(vnorm[r][inext]) };
+            Vertex v10{ rings[r + 1][i],         normalize(vnorm[r + 1][i]) };
+            Vertex v11{ rings[r + 1][inext],     normalize(vnorm[r + 1][inext]) };
 
-            Point n00 = normalize(vnorm[r][i]);
-            Point n10 = normalize(vnorm[r + 1][i]);
-            Point n11 = normalize(vnorm[r + 1][inext]);
-            Point n01 = normalize(vnorm[r][inext]);
+            mesh.verts.push_back(v00); mesh.verts.push_back(v10); mesh.verts.push_back(v11);
+            mesh.verts.push_back(v00); mesh.verts.push_back(v11); mesh.verts.push_back(v01);
+        }
+    }
+    mesh.triVerts = (int)mesh.verts.size();
 
-            glNormal3f(n00.x, n00.y, n00.z); glVertex3f(v00.x, v00.y, v00.z);
-            glNormal3f(n10.x, n10.y, n10.z); glVertex3f(v10.x, v10.y, v10.z);
-            glNormal3f(n11.x, n11.y, n11.z); glVertex3f(v11.x, v11.y, v11.z);
+    // (Optional) base outline
+    for (const auto& p : base) mesh.verts.push_back({ p, { 0.f, 0.f, 1.f } });
+    mesh.loopVerts = (int)mesh.verts.size() - mesh.triVerts;
+    return mesh;
+}
 
-            glNormal3f(n00.x, n00.y, n00.z); glVertex3f(v00.x, v00.y, v00.z);
-            glNormal3f(n11.x, n11.y, n11.z); glVertex3f(v11.x, v11.y, v11.z);
-            glNormal3f(n01.x, n01.y, n01.z); glVertex3f(v01.x, v01.y, v01.z);
+struct ConeParams {
+    float L;
+    int   samples;
+    float innerR, outerR, sweepDeg;
+    int   layers, sectors;
+
+    bool operator==(const ConeParams& o) const {
+        return L == o.L && samples == o.samples && innerR == o.innerR && outerR == o.outerR &&
+               sweepDeg == o.sweepDeg && layers == o.layers && sectors == o.sectors;
+    }
+};
+
+// --- Format compact: 8 B/vertex în loc de 24 (poziție 3 x 16 biți, normală octaedrică 2 x 8 biți) ---
+struct CompactVertex {
+    GLushort pos[3];   // quantized inside the cone's bounding box
+    GLbyte   oct[2];   // octahedral normal, components * 127
+};
+static_assert(sizeof(CompactVertex) == 8, "CompactVertex must stay tightly packed");
+
+// pos = offset + q * scale, q in [0, 65535]
+struct QuantBox {
+    Point offset, scale;
+};
+
+// Bézier stays inside the control polygon, so the petals fit in [0, L] x [-R, R]^2,
+// R = largest control point radius (the four petals are 90 deg rotations of each other)
+static QuantBox coneBounds(const ConeParams& cp) {
+    Point c[4];
+    petalControlPoints(cp.L, cp.innerR, cp.outerR, cp.sweepDeg, c);
+    float R = 0.f;
+    for (const Point& p : c) R = std::fmax(R, std::sqrt(p.y*p.y + p.z*p.z));
+    float lo = std::fmin(0.f, cp.L), hi = std::fmax(0.f, cp.L);
+    return { { lo, -R, -R }, { (hi - lo) / 65535.f, 2 * R / 65535.f, 2 * R / 65535.f } };
+}
+
+static GLushort quantize(float v, float offset, float scale) {
+    float q = scale > 0 ? (v - offset) / scale : 0.f;
+    return (GLushort)std::lround(std::fmin(65535.f, std::fmax(0.f, q)));
+}
+
+static GLbyte snorm8(float v) {
+    return (GLbyte)std::lround(std::fmin(1.f, std::fmax(-1.f, v)) * 127.f);
+}
+
+static CompactVertex packVertex(const Vertex& v, const QuantBox& box) {
+    CompactVertex c;
+    c.pos[0] = quantize(v.pos.x, box.offset.x, box.scale.x);
+    c.pos[1] = quantize(v.pos.y, box.offset.y, box.scale.y);
+    c.pos[2] = quantize(v.pos.z, box.offset.z, box.scale.z);
+
+    const Point& n = v.normal;
+    float s = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float ox = s > 0 ? n.x / s : 0.f, oy = s > 0 ? n.y / s : 0.f;
+    if (n.z < 0) {
+        float fx = (1.f - std::fabs(oy)) * (ox >= 0 ? 1.f : -1.f);
+        float fy = (1.f - std::fabs(ox)) * (oy >= 0 ? 1.f : -1.f);
+        ox = fx; oy = fy;
+    }
+    c.oct[0] = snorm8(ox);
+    c.oct[1] = snorm8(oy);
+    return c;
+}
+
+// Same decode as kConeVS
+static Vertex unpackVertex(const CompactVertex& c, const QuantBox& box) {
+    Vertex v;
+    v.pos = { box.offset.x + c.pos[0] * box.scale.x,
+              box.offset.y + c.pos[1] * box.scale.y,
+              box.offset.z + c.pos[2] * box.scale.z };
+    float x = c.oct[0] / 127.f, y = c.oct[1] / 127.f, z = 1.f - std::fabs(x) - std::fabs(y);
+    if (z < 0) {
+        float fx = (1.f - std::fabs(y)) * (x >= 0 ? 1.f : -1.f);
+        float fy = (1.f - std::fabs(x)) * (y >= 0 ? 1.f : -1.f);
+        x = fx; y = fy;
+    }
+    float len = std::sqrt(x*x + y*y + z*z);
+    v.normal = { x / len, y / len, z / len };
+    return v;
+}
+
+struct CompactError {
+    float maxPos = 0.f;     // world units
+    float posBound = 0.f;   // half a quantization step along the box diagonal
+    float maxNormalDeg = 0.f;
+};
+
+// Decoded triangle vertices of 'mesh' against 'ref' (the mesh itself or a stored reference with
+// the same layout). Triangle vertices only: the outline's normal is never used.
+static CompactError compactError(const ConeMesh& mesh, const QuantBox& box, const ConeMesh& ref) {
+    CompactError e;
+    e.posBound = 0.5f * std::sqrt(box.scale.x*box.scale.x + box.scale.y*box.scale.y + box.scale.z*box.scale.z);
+    for (int k = 0; k < mesh.triVerts && k < ref.triVerts; ++k) {
+        const Vertex& v = ref.verts[k];
+        Vertex d = unpackVertex(packVertex(mesh.verts[k], box), box);
+        e.maxPos = std::fmax(e.maxPos, segLen(v.pos, d.pos));
+        float c = v.normal.x*d.normal.x + v.normal.y*d.normal.y + v.normal.z*d.normal.z;
+        e.maxNormalDeg = std::fmax(e.maxNormalDeg, std::acos(std::fmin(1.f, c)) * 180.0f / (float)M_PI);
+    }
+    return e;
+}
+
+// .cmsh on disk: unique CompactVertex records plus indices stored as zigzag(delta) varints
+static const char kCompactMagic[4] = { 'C', 'M', 'S', 'H' };
+
+struct CompactHeader {
+    char     magic[4];
+    uint32_t version;
+    QuantBox box;
+    uint32_t vertexCount;
+    uint32_t triIndices, loopIndices;
+    uint32_t indexBytes;
+};
+
+static void putVarint(std::vector<unsigned char>& out, uint32_t v) {
+    while (v >= 0x80) { out.push_back((unsigned char)(v | 0x80)); v >>= 7; }
+    out.push_back((unsigned char)v);
+}
+
+static bool getVarint(const unsigned char*& p, const unsigned char* end, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 35; shift += 7) {
+        unsigned char b = *p++;
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// Returns the file size in bytes, 0 on failure
+static size_t saveCompactMesh(const char* path, const ConeMesh& mesh, const QuantBox& box) {
+    std::vector<CompactVertex> verts;
+    std::vector<uint32_t> indices;
+    std::unordered_map<uint64_t, uint32_t> unique;
+    for (const Vertex& v : mesh.verts) {
+        CompactVertex c = packVertex(v, box);
+        uint64_t key;
+        std::memcpy(&key, &c, sizeof(key));
+        auto it = unique.emplace(key, (uint32_t)verts.size());
+        if (it.second) verts.push_back(c);
+        indices.push_back(it.first->second);
+    }
+
+    std::vector<unsigned char> packed;
+    int64_t prev = 0;
+    for (uint32_t i : indices) {
+        int32_t d = (int32_t)((int64_t)i - prev);
+        putVarint(packed, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+        prev = i;
+    }
+
+    CompactHeader h;
+    std::memcpy(h.magic, kCompactMagic, 4);
+    h.version = 1;
+    h.box = box;
+    h.vertexCount = (uint32_t)verts.size();
+    h.triIndices = (uint32_t)mesh.triVerts;
+    h.loopIndices = (uint32_t)mesh.loopVerts;
+    h.indexBytes = (uint32_t)packed.size();
+
+    std::ofstream f(path, std::ios::binary);
+    f.write((const char*)&h, sizeof(h));
+    f.write((const char*)verts.data(), verts.size() * sizeof(CompactVertex));
+    f.write((const char*)packed.data(), packed.size());
+    if (!f) {
+        std::fprintf(stderr, "%s: write failed\n", path);
+        return 0;
+    }
+    return sizeof(h) + verts.size() * sizeof(CompactVertex) + packed.size();
+}
+
+// Decodes on load back to the float, non-indexed ConeMesh layout. The header counts are checked
+// against the file size before anything is allocated from them.
+static bool loadCompactMesh(const char* path, ConeMesh& mesh) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    uint64_t fileSize = f ? (uint64_t)f.tellg() : 0;
+    f.seekg(0);
+    CompactHeader h;
+    if (!f.read((char*)&h, sizeof(h)) || std::memcmp(h.magic, kCompactMagic, 4) != 0 || h.version != 1) {
+        std::fprintf(stderr, "%s: not a compact mesh\n", path);
+        return false;
+    }
+    // Every index takes at least one varint byte; the sums cannot overflow in 64 bits
+    uint64_t indexCount = (uint64_t)h.triIndices + h.loopIndices;
+    if (sizeof(h) + (uint64_t)h.vertexCount * sizeof(CompactVertex) + h.indexBytes != fileSize ||
+        indexCount > h.indexBytes || indexCount > (uint64_t)INT32_MAX) {
+        std::fprintf(stderr, "%s: header does not match the file size (%llu bytes)\n",
+                     path, (unsigned long long)fileSize);
+        return false;
+    }
+    std::vector<CompactVertex> verts(h.vertexCount);
+    std::vector<unsigned char> packed(h.indexBytes);
+    f.read((char*)verts.data(), verts.size() * sizeof(CompactVertex));
+    f.read((char*)packed.data(), packed.size());
+    if (!f) {
+        std::fprintf(stderr, "%s: truncated\n", path);
+        return false;
+    }
+
+    mesh.verts.clear();
+    mesh.verts.reserve((size_t)indexCount);
+    const unsigned char* p = packed.data();
+    const unsigned char* end = p + packed.size();
+    int64_t prev = 0;
+    for (uint64_t k = 0; k < indexCount; ++k) {
+        uint32_t z;
+        if (!getVarint(p, end, z)) {
+            std::fprintf(stderr, "%s: bad index data\n", path);
+            return false;
+        }
+        int64_t i = prev + (int32_t)((z >> 1) ^ (0u - (z & 1)));
+        if (i < 0 || i >= (int64_t)verts.size()) {
+            std::fprintf(stderr, "%s: index out of range\n", path);
+            return false;
+        }
+        mesh.verts.push_back(unpackVertex(verts[(size_t)i], h.box));
+        prev = i;
+    }
+    mesh.triVerts = (int)h.triIndices;
+    mesh.loopVerts = (int)h.loopIndices;
+    return true;
+}
+
+// GPU copy of a ConeMesh; rebuilt only when the cone parameters change
+struct ConeBuffer {
+    GLuint vao = 0, vbo = 0;
+    GLsizei triVerts = 0, loopVerts = 0;
+    ConeParams params{};
+    bool compact = false;   // CompactVertex instead of Vertex
+    QuantBox box{};
+    bool valid = false;
+};
+static ConeBuffer g_cone;
+
+static void uploadBezierCone(ConeBuffer& buf, const ConeParams& cp, bool compact) {
+    if (buf.valid && buf.params == cp && buf.compact == compact) return;
+
+    ConeMesh mesh = buildBezierCone(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg, cp.layers, cp.sectors);
+    if (!buf.vao) {
+        glGenVertexArrays(1, &buf.vao);
+        glGenBuffers(1, &buf.vbo);
+    }
+    bindVertexArray(buf.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buf.vbo);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    if (compact) {
+        buf.box = coneBounds(cp);
+        std::vector<CompactVertex> packed;
+        packed.reserve(mesh.verts.size());
+        for (const Vertex& v : mesh.verts) packed.push_back(packVertex(v, buf.box));
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(CompactVertex), packed.data(), GL_STATIC_DRAW);
+        // Not normalized: the shader applies the box and the 1/127 itself
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, pos));
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, oct));
+
+        CompactError e = compactError(mesh, buf.box, mesh);
+        std::printf("compact cone: %zu -> %zu bytes, max |dp| = %.2e (bound %.2e), normal max %.2f deg\n",
+                    mesh.verts.size() * sizeof(Vertex), packed.size() * sizeof(CompactVertex),
+                    e.maxPos, e.posBound, e.maxNormalDeg);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, mesh.verts.size() * sizeof(Vertex), mesh.verts.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    }
+    bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    buf.triVerts = mesh.triVerts;
+    buf.loopVerts = mesh.loopVerts;
+    buf.params = cp;
+    buf.compact = compact;
+    buf.valid = true;
+}
+
+// Arc length of a cubic Bézier on [0, t]: 4 x 5-point Gauss-Legendre, same rule as arcLen() in kConeGpuVS
+static float petalArcLength(const Point c[4], float t) {
+    static const double x[5] = { -0.9061798459, -0.5384693101, 0.0, 0.5384693101, 0.9061798459 };
+    static const double w[5] = { 0.2369268851, 0.4786286705, 0.5688888889, 0.4786286705, 0.2369268851 };
+    double h = 0.25 * t, sum = 0.0;
+    for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 5; ++j) {
+            double s = h * (k + 0.5 * (x[j] + 1.0)), u = 1.0 - s;
+            double dx = 3.0 * (u*u*(c[1].x-c[0].x) + 2*u*s*(c[2].x-c[1].x) + s*s*(c[3].x-c[2].x));
+            double dy = 3.0 * (u*u*(c[1].y-c[0].y) + 2*u*s*(c[2].y-c[1].y) + s*s*(c[3].y-c[2].y));
+            double dz = 3.0 * (u*u*(c[1].z-c[0].z) + 2*u*s*(c[2].z-c[1].z) + s*s*(c[3].z-c[2].z));
+            sum += w[j] * std::sqrt(dx*dx + dy*dy + dz*dz);
         }
     }
-    glEnd();
+    return (float)(0.5 * h * sum);
+}
 
-    // PASS 2: Interior doar linii (back faces of the chosen winding)
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+// std140 block 'ConeParams' in kConeGpuVS
+struct ConeParamsUBO {
+    GLfloat ctrl[4][4];
+    GLint   grid[4];
+    GLfloat arc[4];
+};
 
-    glCullFace(GL_FRONT);
-    glPolygonMode(GL_BACK, GL_LINE);
-    glLineWidth(1.2f);
-    glColor4f(0.f, 0.f, 0.f, 0.35f);
+// GPU-evaluated cone: only the parameter block lives on the GPU
+struct GpuConeBuffer {
+    GLuint vao = 0, ubo = 0;   // the VAO stays empty, everything comes from gl_VertexID
+    GLsizei triVerts = 0, loopVerts = 0;
+    ConeParams params{};
+    bool valid = false;
+};
+static GpuConeBuffer g_gpuCone;
 
-    glBegin(GL_TRIANGLES);
-    for (int r = 0; r < layers; ++r) {
-        for (int i = 0; i < sectors; ++i) {
-            int inext = (i + 1) % sectors;
-            const Point& v00 = rings[r][i];
-            const Point& v01 = rings[r][inext];
-            const Point& v10 = rings[r + 1][i];
-            const Point& v11 = rings[r + 1][inext];
+static void uploadGpuCone(GpuConeBuffer& buf, const ConeParams& cp) {
+    if (buf.valid && buf.params == cp) return;
 
-            glVertex3f(v00.x, v00.y, v00.z);
-            glVertex3f(v10.x, v10.y, v10.z);
-            glVertex3f(v11.x, v11.y, v11.z);
+    Point ctrl[4];
+    petalControlPoints(cp.L, cp.innerR, cp.outerR, cp.sweepDeg, ctrl);
+    Point next = rotatePetal({ ctrl[0] }, 90.0f)[0];
 
-            glVertex3f(v00.x, v00.y, v00.z);
-            glVertex3f(v11.x, v11.y, v11.z);
-            glVertex3f(v01.x, v01.y, v01.z);
+    int layers  = cp.layers < 0 ? cp.samples : cp.layers;
+    int sectors = cp.sectors > 0 ? cp.sectors : 4 * (cp.samples + 1);
+
+    ConeParamsUBO u{};
+    for (int k = 0; k < 4; ++k) {
+        u.ctrl[k][0] = ctrl[k].x; u.ctrl[k][1] = ctrl[k].y; u.ctrl[k][2] = ctrl[k].z;
+    }
+    u.grid[0] = layers;
+    u.grid[1] = sectors;
+    u.grid[2] = cp.samples;
+    u.grid[3] = cp.sectors > 0 ? 1 : 0;
+    u.arc[0] = petalArcLength(ctrl, 1.0f);
+    u.arc[1] = segLen(ctrl[3], next);
+    u.arc[2] = u.arc[0] + u.arc[1];
+
+    if (!buf.vao) {
+        glGenVertexArrays(1, &buf.vao);
+        glGenBuffers(1, &buf.ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, buf.ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(u), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, buf.ubo);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, buf.ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(u), &u);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    buf.triVerts = layers * sectors * 6;
+    buf.loopVerts = sectors;
+    buf.params = cp;
+    buf.valid = true;
+}
+
+// Petal tips and petal/chord joints: the smooth CPU normal next to such a corner averages both
+// sides, while the analytic normal (kConeGpuVS) follows one of them. Returns the CPU face that
+// 'sector' must match instead: -1 the face before it, +1 the face after it, 2 either (the vertex
+// is on the corner), 0 for a vertex away from the corners (compared with the smooth normal).
+static int petalJunctionSide(const ConeParams& cp, int sector) {
+    if (cp.sectors <= 0) {
+        int j = sector % (cp.samples + 1);   // raw samples: the end points of each petal, curve side
+        return j == 0 ? +1 : j == cp.samples ? -1 : 0;
+    }
+    Point ctrl[4];
+    petalControlPoints(cp.L, cp.innerR, cp.outerR, cp.sweepDeg, ctrl);
+    float curve = petalArcLength(ctrl, 1.0f);
+    float period = curve + segLen(ctrl[3], rotatePetal({ ctrl[0] }, 90.0f)[0]);
+    float step = 4 * period / cp.sectors;
+    for (int k = 0; k < 4; ++k) {
+        const float corners[2] = { k * period, k * period + curve };
+        for (float corner : corners) {
+            // only the two ends of the segment that straddles the corner
+            float c = corner / step;
+            int j = (int)std::floor(c);
+            if (std::fabs(c - std::round(c)) < 1e-3f) {
+                if (sector == (int)std::round(c) % cp.sectors) return 2;
+            } else if (sector == j % cp.sectors) {
+                return -1;
+            } else if (sector == (j + 1) % cp.sectors) {
+                return +1;
+            }
         }
     }
-    glEnd();
+    return 0;
+}
 
-    // Restore state
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
-    glDisable(GL_BLEND);
-    glEnable(GL_LIGHTING);
-    glDisable(GL_CULL_FACE);
+// Readback check: captures the GPU-evaluated triangles with transform feedback and compares
+// them with 'ref' (buildBezierCone() or a stored dump). Positions and normals are bounded at every
+// vertex; at the petal junctions the normal is compared with a face normal (petalJunctionSide).
+static bool verifyGpuCone(const ConeParams& cp, const ConeMesh& ref, float posTol, float normalTolDeg) {
+    uploadGpuCone(g_gpuCone, cp);
+    if (ref.triVerts != g_gpuCone.triVerts) {
+        std::fprintf(stderr, "GPU cone check: %d vertices, expected %d\n", g_gpuCone.triVerts, ref.triVerts);
+        return false;
+    }
+
+    GLuint tfb;
+    glGenBuffers(1, &tfb);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, tfb);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, ref.triVerts * sizeof(Vertex), nullptr, GL_STATIC_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, tfb);
+
+    useProgram(g_coneGpuProg.id);
+    glUniform1i(g_coneGpuProg.uOutline, 0);
+    bindVertexArray(g_gpuCone.vao);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_TRIANGLES);
+    glDrawArrays(GL_TRIANGLES, 0, g_gpuCone.triVerts);
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    std::vector<Vertex> gpu(ref.triVerts);
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, gpu.size() * sizeof(Vertex), gpu.data());
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDeleteBuffers(1, &tfb);
+
+    static const int dr[6] = { 0, 1, 1, 0, 1, 0 };   // v00 v10 v11 | v00 v11 v01
+    static const int di[6] = { 0, 0, 1, 0, 1, 1 };
+    const int sectors = ref.loopVerts;
+
+    // The CPU apex normal only sees the face on one side (the other triangle is degenerate),
+    // while the analytic normal is constant along a ruling: compare apex vertices with ring 1
+    std::vector<Point> ring1(sectors);
+    for (int k = 0; k < ref.triVerts; ++k) {
+        if ((k / 6) / sectors + dr[k % 6] == 1)
+            ring1[((k / 6) % sectors + di[k % 6]) % sectors] = ref.verts[k].normal;
+    }
+    // Face normal of the quads between sector i and i + 1 (all layers are coplanar: the rings are
+    // scaled copies), taken from the outer layer and turned to the side of the smooth normals
+    std::vector<Point> face(sectors);
+    for (int i = 0; i < sectors; ++i) {
+        const Vertex* v = &ref.verts[6 * ((ref.triVerts / (6 * sectors) - 1) * sectors + i)];
+        Point e1{ v[1].pos.x - v[0].pos.x, v[1].pos.y - v[0].pos.y, v[1].pos.z - v[0].pos.z };
+        Point e2{ v[2].pos.x - v[0].pos.x, v[2].pos.y - v[0].pos.y, v[2].pos.z - v[0].pos.z };
+        AccumNormal n;
+        addNormal(n, { e1.y*e2.z - e1.z*e2.y, e1.z*e2.x - e1.x*e2.z, e1.x*e2.y - e1.y*e2.x });
+        face[i] = normalize(n);
+        if (face[i].x*v[0].normal.x + face[i].y*v[0].normal.y + face[i].z*v[0].normal.z < 0)
+            face[i] = { -face[i].x, -face[i].y, -face[i].z };
+    }
+    auto angleDeg = [](const Point& a, const Point& b) {
+        float c = std::fmin(1.f, std::fmax(-1.f, a.x*b.x + a.y*b.y + a.z*b.z));
+        return std::acos(c) * 180.0f / (float)M_PI;
+    };
+
+    float maxPos = 0.f, maxAngle = 0.f, maxJunction = 0.f;
+    for (int k = 0; k < ref.triVerts; ++k) {
+        maxPos = std::fmax(maxPos, segLen(gpu[k].pos, ref.verts[k].pos));
+        int r = (k / 6) / sectors + dr[k % 6];
+        int sector = ((k / 6) % sectors + di[k % 6]) % sectors;
+        const Point& n = gpu[k].normal;
+        const Point& before = face[(sector + sectors - 1) % sectors];
+        const Point& after = face[sector];
+        switch (petalJunctionSide(cp, sector)) {
+        case -1: maxJunction = std::fmax(maxJunction, angleDeg(n, before)); break;
+        case +1: maxJunction = std::fmax(maxJunction, angleDeg(n, after)); break;
+        case 2:  maxJunction = std::fmax(maxJunction, std::fmin(angleDeg(n, before), angleDeg(n, after))); break;
+        default: maxAngle = std::fmax(maxAngle, angleDeg(n, r == 0 ? ring1[sector] : ref.verts[k].normal)); break;
+        }
+    }
+    bool ok = maxPos <= posTol && maxAngle <= normalTolDeg && maxJunction <= normalTolDeg;
+    std::printf("GPU cone check: max |dp| = %.2e, normal max %.2f deg (petal junctions, vs. face normal %.2f) -> %s\n",
+                maxPos, maxAngle, maxJunction, ok ? "OK" : "FAIL");
+    return ok;
+}
+
+// Modify the signature to add 'sectors' (last arg). Keep default as -1 to preserve current behavior.
+// drawScene() draws the opaque part of every cone before any interior: the interior's blended
+// edges do not write depth, so an edge never hides a surface that is drawn after it.
+// The caller sets the culling (back faces for the surface, front faces for the interior).
+enum ConePass { kConeSurface, kConeInterior };
+
+void drawBezierCone(float L = 3.0f, int samples = 50, float innerR = 0.4f, float outerR = 2.4f,
+                    float sweepDeg = 0.0f, int layers = -1, int sectors = -1, int windingSign = +1,
+                    ConePass pass = kConeSurface) {
+    const ConeParams cp{ L, samples, innerR, outerR, sweepDeg, layers, sectors };
+    const ConeProgram& p = g_gpuConeMode ? g_coneGpuProg : g_coneProg;
+    GLsizei triVerts, loopVerts;
+    if (g_gpuConeMode) {
+#ifdef _DEBUG
+        // Compare against the CPU mesh once per parameter change
+        if (!(g_gpuCone.valid && g_gpuCone.params == cp))
+            verifyGpuCone(cp, buildBezierCone(L, samples, innerR, outerR, sweepDeg, layers, sectors), 1e-3f * L, 5.0f);
+#endif
+        uploadGpuCone(g_gpuCone, cp);
+        bindVertexArray(g_gpuCone.vao);
+        triVerts = g_gpuCone.triVerts;
+        loopVerts = g_gpuCone.loopVerts;
+    } else {
+        uploadBezierCone(g_cone, cp, g_compactMode);
+        bindVertexArray(g_cone.vao);
+        triVerts = g_cone.triVerts;
+        loopVerts = g_cone.loopVerts;
+    }
+
+    useProgram(p.id);
+    uploadMatrices(p.uModelView, p.uProjection);
+    if (!g_gpuConeMode) {
+        glUniform1i(p.uCompact, g_cone.compact ? 1 : 0);
+        glUniform3f(p.uPosOffset, g_cone.box.offset.x, g_cone.box.offset.y, g_cone.box.offset.z);
+        glUniform3f(p.uPosScale, g_cone.box.scale.x, g_cone.box.scale.y, g_cone.box.scale.z);
+    }
+
+    // Adjust front-face depending on mirror parity; gl_FrontFacing picks exterior vs. interior
+    setFrontFace(windingSign < 0 ? GL_CCW : GL_CW);
+
+    // Exterior neted sau interior doar linii, același VAO și același program
+    glUniform1i(p.uUnlit, 0);
+    glUniform1i(p.uOutline, 0);
+    glUniform3f(p.uColor, 0.7f, 0.2f, 0.8f);
+    glDrawArrays(GL_TRIANGLES, 0, triVerts);
+    countDraw();
+    if (pass == kConeInterior) return;
 
     // (Optional) base outline
-    glDisable(GL_LIGHTING);
-    glColor3d(0.2, 0.5, 0.9);
-    glBegin(GL_LINE_LOOP);
-    for (const auto& p : base) glVertex3f(p.x, p.y, p.z);
-    glEnd();
-    glEnable(GL_LIGHTING);
+    setLineWidth(1.2f);
+    glUniform1i(p.uUnlit, 1);
+    glUniform3f(p.uColor, 0.2f, 0.5f, 0.9f);
+    if (g_gpuConeMode) {
+        glUniform1i(p.uOutline, 1);
+        glDrawArrays(GL_LINE_LOOP, 0, loopVerts);
+    } else {
+        glDrawArrays(GL_LINE_LOOP, triVerts, loopVerts);
+    }
+    countDraw();
+}
+
+// --- Scenă statică: axe + săgeți, construite o singură dată ---
+struct HelperInstance {
+    GLfloat color[3];
+    GLfloat model[16];   // column-major, rotates local +Z onto the axis
+};
+
+struct StaticScene {
+    GLuint vao = 0, vbo = 0, instanceVbo = 0;
+    GLsizei lineFirst = 0, lineVerts = 0;     // axis line along local Z (GL_LINES)
+    GLsizei arrowFirst = 0, arrowVerts = 0;   // arrow head at the +Z end (GL_TRIANGLES)
+    GLsizei instances = 0;
+};
+static StaticScene g_scene;
+static ConeProgram g_sceneProg;
+
+// Same shape as glutSolidCone(base, height, slices, ...), moved 'offset' along +Z
+static void appendArrowHead(std::vector<Vertex>& out, float base, float height, int slices, float offset) {
+    float nlen = std::sqrt(height * height + base * base);
+    for (int i = 0; i < slices; ++i) {
+        float a0 = 2.0f * (float)M_PI * i / slices;
+        float a1 = 2.0f * (float)M_PI * (i + 1) / slices;
+        float am = 0.5f * (a0 + a1);
+        Point b0{ base * std::cos(a0), base * std::sin(a0), offset };
+        Point b1{ base * std::cos(a1), base * std::sin(a1), offset };
+        Point apex{ 0.f, 0.f, offset + height };
+        Point n0{ height * std::cos(a0) / nlen, height * std::sin(a0) / nlen, base / nlen };
+        Point n1{ height * std::cos(a1) / nlen, height * std::sin(a1) / nlen, base / nlen };
+        Point nm{ height * std::cos(am) / nlen, height * std::sin(am) / nlen, base / nlen };
+
+        out.push_back({ b0, n0 }); out.push_back({ b1, n1 }); out.push_back({ apex, nm });
+        // capac
+        out.push_back({ { 0.f, 0.f, offset }, { 0.f, 0.f, -1.f } });
+        out.push_back({ b1, { 0.f, 0.f, -1.f } });
+        out.push_back({ b0, { 0.f, 0.f, -1.f } });
+    }
+}
+
+static void buildStaticScene(StaticScene& sc) {
+    std::vector<Vertex> verts;
+    sc.lineFirst = 0;
+    verts.push_back({ { 0.f, 0.f, -5.5f }, { 0.f, 0.f, 1.f } });
+    verts.push_back({ { 0.f, 0.f, +5.5f }, { 0.f, 0.f, 1.f } });
+    sc.lineVerts = 2;
+    sc.arrowFirst = (GLsizei)verts.size();
+    appendArrowHead(verts, 0.1f, 0.2f, 16, 5.3f);
+    sc.arrowVerts = (GLsizei)verts.size() - sc.arrowFirst;
+
+    // X: +Z -> +X, Y: +Z -> +Y, Z: identitate (ca rotațiile de dinainte pentru glutSolidCone)
+    const HelperInstance inst[3] = {
+        { { 1.f, 0.f, 0.f }, { 0, 0, -1, 0,   0, 1, 0, 0,   1, 0, 0, 0,   0, 0, 0, 1 } },
+        { { 0.f, 1.f, 0.f }, { 1, 0, 0, 0,    0, 0, -1, 0,  0, 1, 0, 0,   0, 0, 0, 1 } },
+        { { 0.f, 0.f, 1.f }, { 1, 0, 0, 0,    0, 1, 0, 0,   0, 0, 1, 0,   0, 0, 0, 1 } },
+    };
+    sc.instances = 3;
+
+    glGenVertexArrays(1, &sc.vao);
+    glGenBuffers(1, &sc.vbo);
+    glGenBuffers(1, &sc.instanceVbo);
+    bindVertexArray(sc.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, sc.vbo);
+    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(Vertex), verts.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+
+    glBindBuffer(GL_ARRAY_BUFFER, sc.instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(inst), inst, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(HelperInstance), (void*)offsetof(HelperInstance, color));
+    glVertexAttribDivisor(2, 1);
+    for (int c = 0; c < 4; ++c) {
+        glEnableVertexAttribArray(3 + c);
+        glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(HelperInstance),
+                              (void*)(offsetof(HelperInstance, model) + c * 4 * sizeof(GLfloat)));
+        glVertexAttribDivisor(3 + c, 1);
+    }
+
+    bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Axes (unlit) and arrow heads (lit): one instanced draw each
+static void drawStaticScene(const StaticScene& sc) {
+    const ConeProgram& p = g_sceneProg;
+    useProgram(p.id);
+    bindVertexArray(sc.vao);
+    setFrontFace(GL_CCW);   // the cones leave theirs; gl_FrontFacing drops the back faces here
+    uploadMatrices(p.uModelView, p.uProjection);
+
+    setLineWidth(1.5f);
+    glUniform1i(p.uUnlit, 1);
+    glDrawArraysInstanced(GL_LINES, sc.lineFirst, sc.lineVerts, sc.instances);
+    countDraw();
+
+    glUniform1i(p.uUnlit, 0);
+    glDrawArraysInstanced(GL_TRIANGLES, sc.arrowFirst, sc.arrowVerts, sc.instances);
+    countDraw();
 }
 
 void resize(int width, int height) {
@@ -299,17 +1259,33 @@ void resize(int width, int height) {
     glMatrixMode(GL_MODELVIEW);
 }
 
-void display() {
+// Averages the counters over ~1 s and puts them in the window title
+static void reportFrameStats() {
+    FrameStats& st = g_frameStats;
+    st.frames++;
+    st.sumDraws += st.drawCalls;
+    st.sumStates += st.stateChanges;
+    st.drawCalls = st.stateChanges = 0;
+
+    int now = glutGet(GLUT_ELAPSED_TIME);
+    if (now - st.lastReportMs < 1000) return;
+    char title[160];
+    std::snprintf(title, sizeof(title), "Con cu baza Bézier - %.0f fps, %.1f draws, %.1f state changes / frame%s",
+                  st.frames * 1000.0 / (now - st.lastReportMs), st.sumDraws / st.frames,
+                  st.sumStates / st.frames, g_gpuConeMode ? " [GPU]" : g_compactMode ? " [compact]" : "");
+    glutSetWindowTitle(title);
+    st.frames = 0;
+    st.sumDraws = st.sumStates = 0;
+    st.lastReportMs = now;
+}
+
+// The cone drawScene() draws (both copies) and E exports
+static const ConeParams kSceneCone{ 3.0f, 60, 0.5f, 2.5f, 0.0f, 7, 96 };
+
+void drawScene() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Light position (world space)
     glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    GLfloat lightPos[]  = { 5.0f, 8.0f, 7.0f, 1.0f };
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glPopMatrix();
-
     glPushMatrix();
     glTranslated(0., 0., -6.0);
     glRotated(35., 1., 0., 0.);
@@ -317,80 +1293,543 @@ void display() {
     glRotated(g_rotX, 1., 0., 0.);
     glRotated(g_rotY, 0., 1., 0.);
 
-    // Axes (unlit)
-    glDisable(GL_LIGHTING);
-    glLineWidth(1.5f);
-    glBegin(GL_LINES);
-    glColor3d(1., 0., 0.); glVertex3d(-5.5, 0., 0.); glVertex3d(5.5, 0., 0.);
-    glColor3d(0., 1., 0.); glVertex3d(0., -5.5, 0.); glVertex3d(0., 5.5, 0.);
-    glColor3d(0., 0., 1.); glVertex3d(0., 0., -5.5); glVertex3d(0., 0., 5.5);
-    glEnd();
-    glEnable(GL_LIGHTING);
-
-    // Conuri capete axe (optional)
-    glColor3d(1, 0, 0);
-    glPushMatrix(); glTranslated(5.3, 0.0, 0.0); glRotated(90, 0, 1, 0); glutSolidCone(0.1, 0.2, 16, 16); glPopMatrix();
-    glColor3d(0, 1, 0);
-    glPushMatrix(); glTranslated(0.0, 5.3, 0.0); glRotated(-90, 1, 0, 0); glutSolidCone(0.1, 0.2, 16, 16); glPopMatrix();
-    glColor3d(0, 0, 1);
-    glPushMatrix(); glTranslated(0.0, 0.0, 5.3); glutSolidCone(0.1, 0.2, 16, 16); glPopMatrix();
-
-    // Original cone: apex at origin, base toward +X
-    drawBezierCone(3.0f, 60, 0.5f, 2.5f, 0.0f, 7, 96, +1);
-
-    // Mirrored cone: apex at origin, base toward -X
-    glPushMatrix();
-    glScalef(-1.f, 1.f, 1.f);          // mirror across YZ plane
-    drawBezierCone(3.0f, 60, 0.5f, 2.5f, 0.0f, 7, 96, -1);
-    glPopMatrix();
+    // Axe + conuri capete axe
+    drawStaticScene(g_scene);
+
+    // Both cones' exteriors and outlines, then both interiors without depth writes
+    const ConeParams& c = kSceneCone;
+    glEnable(GL_CULL_FACE);
+    countState();
+    for (ConePass pass : { kConeSurface, kConeInterior }) {
+        glCullFace(pass == kConeSurface ? GL_BACK : GL_FRONT);
+        glDepthMask(pass == kConeSurface ? GL_TRUE : GL_FALSE);
+        countState(2);
+
+        // Original cone: apex at origin, base toward +X
+        drawBezierCone(c.L, c.samples, c.innerR, c.outerR, c.sweepDeg, c.layers, c.sectors, +1, pass);
+
+        // Mirrored cone: apex at origin, base toward -X
+        glPushMatrix();
+        glScalef(-1.f, 1.f, 1.f);          // mirror across YZ plane
+        drawBezierCone(c.L, c.samples, c.innerR, c.outerR, c.sweepDeg, c.layers, c.sectors, -1, pass);
+        glPopMatrix();
+    }
+    glDepthMask(GL_TRUE);
+    glDisable(GL_CULL_FACE);
+    countState(2);
 
     glPopMatrix();
+}
+
+// E: file I/O and the mesh rebuild stay out of the draw path, once per request
+static void exportSceneCone() {
+    const ConeParams& cp = kSceneCone;
+    ConeMesh mesh = buildBezierCone(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg, cp.layers, cp.sectors);
+    size_t bytes = saveCompactMesh("con.cmsh", mesh, coneBounds(cp));
+    if (bytes) std::printf("con.cmsh: %zu bytes (float vertices: %zu)\n", bytes, mesh.verts.size() * sizeof(Vertex));
+}
+
+void display() {
+    if (g_exportMesh) {
+        g_exportMesh = false;
+        exportSceneCone();
+    }
+    drawScene();
     glutSwapBuffers();
+    reportFrameStats();
+}
+
+// --- Self-test (--selftest): geometrie + randare offscreen, pentru fiecare mod al conului ---
+static int g_testFailures = 0;
+
+static void check(bool ok, const char* what) {
+    std::printf("[%s] %s\n", ok ? " OK " : "FAIL", what);
+    if (!ok) ++g_testFailures;
+}
+
+static bool closeTo(const Point& a, const Point& b, float tol) { return segLen(a, b) <= tol; }
+
+static float distToSegment(const Point& p, const Point& a, const Point& b) {
+    Point ab{ b.x - a.x, b.y - a.y, b.z - a.z };
+    float len2 = ab.x*ab.x + ab.y*ab.y + ab.z*ab.z;
+    float t = len2 > 0 ? ((p.x-a.x)*ab.x + (p.y-a.y)*ab.y + (p.z-a.z)*ab.z) / len2 : 0.f;
+    t = std::fmin(1.f, std::fmax(0.f, t));
+    return segLen(p, { a.x + ab.x*t, a.y + ab.y*t, a.z + ab.z*t });
+}
+
+// Reference values are analytic (Bézier end/mid points, rotations, cone invariants)
+static void selfTestGeometry(const ConeParams& cp) {
+    Point c[4];
+    petalControlPoints(cp.L, cp.innerR, cp.outerR, cp.sweepDeg, c);
+    Point mid{ (c[0].x + 3*c[1].x + 3*c[2].x + c[3].x) / 8,
+               (c[0].y + 3*c[1].y + 3*c[2].y + c[3].y) / 8,
+               (c[0].z + 3*c[1].z + 3*c[2].z + c[3].z) / 8 };
+    check(closeTo(bezier(c[0], c[1], c[2], c[3], 0.f), c[0], 1e-6f) &&
+          closeTo(bezier(c[0], c[1], c[2], c[3], 1.f), c[3], 1e-6f) &&
+          closeTo(bezier(c[0], c[1], c[2], c[3], 0.5f), mid, 1e-5f), "bezier: end points and t = 0.5");
+
+    auto petal = generatePetal(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg);
+    bool planar = true;
+    for (const auto& p : petal) planar = planar && std::fabs(p.x - cp.L) <= 1e-5f;
+    check((int)petal.size() == cp.samples + 1 && closeTo(petal.front(), c[0], 1e-6f) &&
+          closeTo(petal.back(), c[3], 1e-6f) && planar, "generatePetal: samples + 1 points in the plane x = L");
+
+    auto rotated = rotatePetal(petal, 90.0f);
+    bool rot = true;
+    for (size_t i = 0; i < petal.size(); ++i)
+        rot = rot && closeTo(rotated[i], { petal[i].x, -petal[i].z, petal[i].y }, 1e-5f);
+    check(rot, "rotatePetal: 90 deg maps (x, y, z) to (x, -z, y)");
+
+    std::vector<Point> base;
+    for (int k = 0; k < 4; ++k) {
+        auto r = rotatePetal(petal, k * 90.0f);
+        base.insert(base.end(), r.begin(), r.end());
+    }
+    const int target = cp.sectors > 0 ? cp.sectors : 96;
+    auto loop = resampleClosedLoop(base, target);
+    float total = 0.f;
+    for (size_t i = 0; i < base.size(); ++i) total += segLen(base[i], base[(i + 1) % base.size()]);
+    bool onLoop = true, spacing = true;
+    for (int k = 0; k < (int)loop.size(); ++k) {
+        float best = 1e9f;
+        for (size_t i = 0; i < base.size(); ++i)
+            best = std::fmin(best, distToSegment(loop[k], base[i], base[(i + 1) % base.size()]));
+        onLoop = onLoop && best <= 1e-4f;
+        spacing = spacing && segLen(loop[k], loop[(k + 1) % loop.size()]) <= total / target * 1.001f;
+    }
+    check((int)loop.size() == target && closeTo(loop[0], base[0], 1e-6f) && onLoop && spacing,
+          "resampleClosedLoop: target points on the loop, at most one arc step apart");
+
+    ConeMesh mesh = buildBezierCone(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg, cp.layers, cp.sectors);
+    int layers = cp.layers < 0 ? cp.samples : cp.layers;
+    int sectors = cp.sectors > 0 ? cp.sectors : 4 * (cp.samples + 1);
+    check(mesh.triVerts == layers * sectors * 6 && mesh.loopVerts == sectors, "buildBezierCone: vertex counts");
+
+    // Rings are scaled copies of the base, so every smooth normal is perpendicular to its ruling
+    bool unit = true, perp = true, apex = true;
+    for (int k = 0; k < mesh.triVerts; ++k) {
+        const Vertex& v = mesh.verts[k];
+        float len = std::sqrt(v.normal.x*v.normal.x + v.normal.y*v.normal.y + v.normal.z*v.normal.z);
+        float r = std::sqrt(v.pos.x*v.pos.x + v.pos.y*v.pos.y + v.pos.z*v.pos.z);
+        unit = unit && std::fabs(len - 1.f) <= 1e-4f;
+        if (r > 1e-6f)
+            perp = perp && std::fabs(v.pos.x*v.normal.x + v.pos.y*v.normal.y + v.pos.z*v.normal.z) / r <= 1e-3f;
+        if (k < 6 * sectors) {
+            // first layer: corners 0, 3, 5 of each quad are on ring 0, the others on ring 1
+            int corner = k % 6;
+            bool onApex = corner == 0 || corner == 3 || corner == 5;
+            apex = apex && (onApex ? r == 0.f : r > 0.f);
+        }
+    }
+    bool outline = true;
+    for (int k = 0; k < mesh.loopVerts; ++k) outline = outline && std::fabs(mesh.verts[mesh.triVerts + k].pos.x - cp.L) <= 1e-5f;
+    check(unit && perp, "buildBezierCone: unit normals, perpendicular to the rulings");
+    check(apex && outline, "buildBezierCone: first ring at the apex, outline at x = L");
+}
+
+// Framebuffer for the whole self-test: an EGL surfaceless context has no default one,
+// so even the transform feedback pass needs a complete framebuffer bound
+struct OffscreenTarget {
+    GLuint fbo = 0, rb[2] = { 0, 0 };
+    int size = 0;   // same framing as a window of this size (resize() keeps a 10 px margin)
+};
+
+static OffscreenTarget createOffscreenTarget(int size) {
+    OffscreenTarget t;
+    t.size = size;
+    glGenFramebuffers(1, &t.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, t.fbo);
+    glGenRenderbuffers(2, t.rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, t.rb[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, t.rb[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, t.rb[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, t.rb[1]);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    return t;
+}
+
+static void destroyOffscreenTarget(OffscreenTarget& t) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(2, t.rb);
+    glDeleteFramebuffers(1, &t.fbo);
+    t = OffscreenTarget();
+}
+
+// Draws the scene into the bound target, RGBA rows bottom-up
+static std::vector<unsigned char> renderOffscreen(const OffscreenTarget& t) {
+    resize(t.size, t.size);
+    drawScene();
+    std::vector<unsigned char> px((size_t)t.size * t.size * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, t.size, t.size, GL_RGBA, GL_UNSIGNED_BYTE, px.data());
+    return px;
+}
+
+// Depth buffer of the last frame drawn into the target
+static std::vector<float> readDepth(const OffscreenTarget& t) {
+    std::vector<float> depth((size_t)t.size * t.size);
+    glReadPixels(0, 0, t.size, t.size, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+    return depth;
+}
+
+// uWire for both cone programs (false: the interiors are discarded)
+static void setConeWire(bool wire) {
+    for (const ConeProgram* p : { &g_coneProg, &g_coneGpuProg }) {
+        useProgram(p->id);
+        glUniform1i(glGetUniformLocation(p->id, "uWire"), wire ? 1 : 0);
+    }
+}
+
+// Pixel classes of the reference images, stored in their alpha channel (selftest/README.md)
+enum PixelClass { kLineLayer = 0, kArrowHeads = 128, kSurface = 255 };
+
+// Fraction of the 'cls' pixels (by the alpha of the reference image 'classes') where 'b' has no
+// pixel within 'radius' whose largest channel difference from 'a' is at most 'channelTol'.
+// Pixels that are background (white) in both images count neither as compared nor as differing.
+static double pixelMismatch(const std::vector<unsigned char>& classes, PixelClass cls, int size,
+                            const std::vector<unsigned char>& a, const std::vector<unsigned char>& b,
+                            int channelTol, int radius) {
+    auto background = [](const unsigned char* p) { return p[0] == 255 && p[1] == 255 && p[2] == 255; };
+    size_t compared = 0, bad = 0;
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x) {
+            size_t i = ((size_t)y * size + x) * 4;
+            if (classes[i + 3] != cls || (background(&a[i]) && background(&b[i]))) continue;
+            ++compared;
+            int best = 256;
+            for (int ny = std::max(y - radius, 0); ny <= std::min(y + radius, size - 1); ++ny)
+                for (int nx = std::max(x - radius, 0); nx <= std::min(x + radius, size - 1); ++nx) {
+                    size_t j = ((size_t)ny * size + nx) * 4;
+                    int d = 0;
+                    for (int c = 0; c < 3; ++c) d = std::max(d, std::abs((int)a[i + c] - (int)b[j + c]));
+                    best = std::min(best, d);
+                }
+            if (best > channelTol) ++bad;
+        }
+    return compared ? (double)bad / compared : 0.0;
+}
+
+// --- Reference outputs of the original fixed-function renderer (selftest/README.md) ---
+static bool readFileBytes(const std::string& path, std::vector<unsigned char>& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    in.seekg(0, std::ios::end);
+    out.resize((size_t)in.tellg());
+    in.seekg(0);
+    in.read((char*)out.data(), out.size());
+    return (bool)in;
+}
+
+template <typename T>
+static bool readDumpArray(const unsigned char*& p, const unsigned char* end, std::vector<T>& v) {
+    uint32_t n;
+    if (end - p < 4) return false;
+    std::memcpy(&n, p, 4);
+    p += 4;
+    if (n > (size_t)(end - p) / sizeof(T)) return false;
+    v.resize(n);
+    std::memcpy(v.data(), p, n * sizeof(T));
+    p += n * sizeof(T);
+    return true;
+}
+
+struct ReferenceDump {
+    ConeParams params;
+    std::vector<Point> petal;   // generatePetal()
+    std::vector<Point> loop;    // the four petals, resampled when sectors > 0
+    ConeMesh mesh;              // triangles (position + smooth normal), then the outline
+};
+
+// .vtx: "VTXD", version 1, ConeParams, then petal, loop, triangle (Vertex) and outline arrays,
+// each a uint32 count followed by the records (little-endian floats)
+static bool loadReferenceDump(const std::string& path, ReferenceDump& d) {
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(path, bytes)) {
+        std::fprintf(stderr, "%s: cannot read\n", path.c_str());
+        return false;
+    }
+    const unsigned char* p = bytes.data();
+    const unsigned char* end = p + bytes.size();
+    uint32_t version = 0;
+    std::vector<Point> outline;
+    bool ok = bytes.size() >= 8 + sizeof(ConeParams) && std::memcmp(p, "VTXD", 4) == 0;
+    if (ok) {
+        std::memcpy(&version, p + 4, 4);
+        std::memcpy(&d.params, p + 8, sizeof(ConeParams));
+        p += 8 + sizeof(ConeParams);
+        ok = version == 1 && readDumpArray(p, end, d.petal) && readDumpArray(p, end, d.loop) &&
+             readDumpArray(p, end, d.mesh.verts) && readDumpArray(p, end, outline) && p == end;
+    }
+    if (!ok) {
+        std::fprintf(stderr, "%s: not a version 1 vertex dump\n", path.c_str());
+        return false;
+    }
+    d.mesh.triVerts = (int)d.mesh.verts.size();
+    d.mesh.loopVerts = (int)outline.size();
+    for (const Point& q : outline) d.mesh.verts.push_back({ q, { 0.f, 0.f, 1.f } });
+    return true;
+}
+
+static float maxDistance(const std::vector<Point>& a, const std::vector<Point>& b) {
+    if (a.size() != b.size()) return INFINITY;
+    float m = 0.f;
+    for (size_t i = 0; i < a.size(); ++i) m = std::fmax(m, segLen(a[i], b[i]));
+    return m;
+}
+
+// The current geometry code against the stored output of the original one
+static void selfTestReference(const ReferenceDump& d) {
+    const ConeParams& cp = d.params;
+    char what[160];
+    auto petal = generatePetal(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg);
+    float dp = maxDistance(petal, d.petal);
+    std::snprintf(what, sizeof(what), "generatePetal vs. reference: max |dp| %.2e", dp);
+    check(dp <= 1e-5f, what);
+
+    std::vector<Point> base;
+    for (int k = 0; k < 4; ++k) {
+        auto r = rotatePetal(petal, k * 90.0f);
+        base.insert(base.end(), r.begin(), r.end());
+    }
+    if (cp.sectors > 0) base = resampleClosedLoop(base, cp.sectors);
+    dp = maxDistance(base, d.loop);
+    std::snprintf(what, sizeof(what), "base loop vs. reference: max |dp| %.2e", dp);
+    check(dp <= 1e-5f, what);
+
+    ConeMesh mesh = buildBezierCone(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg, cp.layers, cp.sectors);
+    bool counts = mesh.triVerts == d.mesh.triVerts && mesh.loopVerts == d.mesh.loopVerts;
+    float maxPos = 0.f, maxNormal = 0.f;
+    for (size_t k = 0; counts && k < mesh.verts.size(); ++k) {
+        maxPos = std::fmax(maxPos, segLen(mesh.verts[k].pos, d.mesh.verts[k].pos));
+        if ((int)k < mesh.triVerts) maxNormal = std::fmax(maxNormal, segLen(mesh.verts[k].normal, d.mesh.verts[k].normal));
+    }
+    std::snprintf(what, sizeof(what), "buildBezierCone vs. reference: %d + %d vertices, max |dp| %.2e, max |dn| %.2e",
+                  mesh.triVerts, mesh.loopVerts, maxPos, maxNormal);
+    check(counts && maxPos <= 1e-5f && maxNormal <= 1e-4f, what);
 }
 
-int main() {
-    int argc = 1; char arg0[] = "app"; char* argv[] = { arg0, nullptr };
+// Returns the process exit code. Every cone mode is compared with the stored vertex dumps and
+// with the images the original renderer produced for the same views; the line pixels those images
+// leave out are compared with the CPU mesh render instead.
+static int runSelfTest(const std::string& refDir) {
+    const int kReferenceSize = 276;   // size the reference images were rendered at
+    OffscreenTarget target = createOffscreenTarget(kReferenceSize);
+    check(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "offscreen framebuffer complete");
+
+    const char* const dumps[] = {
+        "cone_display.vtx",     // the cone display() draws
+        "cone_raw_sweep.vtx",   // raw samples, petals with sweep
+    };
+    std::vector<ReferenceDump> refs;
+    for (const char* name : dumps) {
+        ReferenceDump d;
+        bool loaded = loadReferenceDump(refDir + "/" + name, d);
+        check(loaded, (std::string("reference dump ") + name).c_str());
+        if (loaded) refs.push_back(d);
+    }
+    check(!refs.empty() && refs[0].params == kSceneCone, "cone_display.vtx holds the cone drawScene() draws");
+    for (const ReferenceDump& d : refs) {
+        selfTestGeometry(d.params);
+        selfTestReference(d);
+    }
+
+    for (const ReferenceDump& d : refs)
+        check(verifyGpuCone(d.params, d.mesh, 1e-3f * d.params.L, 5.0f), "GPU cone: transform feedback readback vs. reference");
+
+    for (const ReferenceDump& d : refs) {
+        const ConeParams& cp = d.params;
+        ConeMesh mesh = buildBezierCone(cp.L, cp.samples, cp.innerR, cp.outerR, cp.sweepDeg, cp.layers, cp.sectors);
+        QuantBox box = coneBounds(cp);
+        CompactError e = compactError(mesh, box, d.mesh);
+        char what[160];
+        std::snprintf(what, sizeof(what), "compact vertices vs. reference: max |dp| %.2e <= %.2e, normal max %.2f deg <= 1 deg",
+                      e.maxPos, e.posBound, e.maxNormalDeg);
+        check(mesh.triVerts == d.mesh.triVerts && e.maxPos <= e.posBound * 1.01f && e.maxNormalDeg <= 1.0f, what);
+
+        const char* path = "selftest.cmsh";
+        size_t bytes = saveCompactMesh(path, mesh, box);
+        ConeMesh loaded;
+        bool same = bytes > 0 && loadCompactMesh(path, loaded) && loaded.triVerts == mesh.triVerts &&
+                    loaded.loopVerts == mesh.loopVerts && loaded.verts.size() == mesh.verts.size();
+        for (size_t k = 0; same && k < mesh.verts.size(); ++k) {
+            Vertex v = unpackVertex(packVertex(mesh.verts[k], box), box);
+            same = closeTo(loaded.verts[k].pos, v.pos, 0.f) && closeTo(loaded.verts[k].normal, v.normal, 0.f);
+        }
+        size_t floatBytes = mesh.verts.size() * sizeof(Vertex);
+        std::snprintf(what, sizeof(what), ".cmsh round trip: %zu bytes vs. %zu float (%.1fx)",
+                      bytes, floatBytes, bytes ? (double)floatBytes / bytes : 0.0);
+        check(same && bytes * 3 <= floatBytes, what);
+
+        // Header fields that would allocate gigabytes or overflow the index count
+        std::vector<unsigned char> original;
+        bool rejected = readFileBytes(path, original) && original.size() >= sizeof(CompactHeader);
+        for (int c = 0; rejected && c < 3; ++c) {
+            CompactHeader h;
+            std::memcpy(&h, original.data(), sizeof(h));
+            if (c == 0) h.vertexCount = 0xF0000000u;
+            if (c == 1) { h.triIndices = 0xFFFFFFFFu; h.loopIndices = 2; }   // wraps to 1 in 32 bits
+            if (c == 2) h.indexBytes = 0xF0000000u;
+            std::vector<unsigned char> damaged = original;
+            std::memcpy(damaged.data(), &h, sizeof(h));
+            std::ofstream(path, std::ios::binary).write((const char*)damaged.data(), damaged.size());
+            ConeMesh corrupt;
+            rejected = !loadCompactMesh(path, corrupt);
+        }
+        check(rejected, ".cmsh: headers that do not match the file size are rejected");
+        std::remove(path);
+    }
+
+    const float views[][2] = { { 0.f, 0.f }, { -60.f, 120.f }, { -60.f, -60.f } };
+    for (const auto& v : views) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "view_%g_%g.rgba", v[0], v[1]);
+        std::vector<unsigned char> reference;
+        if (!readFileBytes(refDir + "/" + name, reference) || reference.size() != (size_t)kReferenceSize * kReferenceSize * 4) {
+            check(false, (std::string("reference image ") + name).c_str());
+            continue;
+        }
+        g_rotX = v[0]; g_rotY = v[1];
+        // Surfaces and arrow heads compare per pixel. The line layer (axes, outlines, interior
+        // wireframe) may match one pixel off and with a larger color error: GL_LINE rasterization
+        // and the barycentric wireframe differ, but a missing line or wireframe does not pass.
+        // The GPU mode's analytic normals take one side of the petal junction creases, which the
+        // CPU mesh averages, so its surfaces get more room.
+        auto compare = [&](const char* mode, const char* against, const std::vector<unsigned char>& a,
+                           const std::vector<unsigned char>& px, double surfaceTol) {
+            double surface = pixelMismatch(reference, kSurface, kReferenceSize, a, px, 24, 0);
+            double arrows = pixelMismatch(reference, kArrowHeads, kReferenceSize, a, px, 24, 0);
+            double lines = pixelMismatch(reference, kLineLayer, kReferenceSize, a, px, 64, 1);
+            char what[200];
+            std::snprintf(what, sizeof(what), "render rot (%g, %g): %s mode vs. %s, pixels differ: surfaces %.2f%%, "
+                          "arrow heads %.1f%%, line layer %.1f%%", v[0], v[1], mode, against,
+                          surface * 100.0, arrows * 100.0, lines * 100.0);
+            check(surface <= surfaceTol && arrows <= 0.2 && lines <= 0.2, what);
+        };
+        const char* names[] = { "CPU mesh", "GPU", "compact" };
+        std::vector<unsigned char> cpu;
+        for (int m = 0; m < 3; ++m) {
+            g_gpuConeMode = m == 1;
+            g_compactMode = m == 2;
+            auto px = renderOffscreen(target);
+            double surfaceTol = m == 1 ? 0.03 : 0.005;
+            compare(names[m], name, reference, px, surfaceTol);
+            if (m == 0)
+                cpu = px;
+            else
+                compare(names[m], "CPU mesh", cpu, px, surfaceTol);
+        }
+
+        // The interiors blend over what is behind them: same depth as the surfaces alone
+        g_gpuConeMode = g_compactMode = false;
+        renderOffscreen(target);
+        std::vector<float> withEdges = readDepth(target);
+        setConeWire(false);
+        renderOffscreen(target);
+        bool sameDepth = withEdges == readDepth(target);
+        setConeWire(true);
+        char what[128];
+        std::snprintf(what, sizeof(what), "render rot (%g, %g): interior edges do not write depth", v[0], v[1]);
+        check(sameDepth, what);
+    }
+    g_gpuConeMode = g_compactMode = false;
+    g_rotX = g_rotY = 0.0f;
+    check(glGetError() == GL_NO_ERROR, "no GL errors");
+    destroyOffscreenTarget(target);
+
+    std::printf("%s (%d failure%s)\n", g_testFailures ? "SELFTEST FAILED" : "selftest passed",
+                g_testFailures, g_testFailures == 1 ? "" : "s");
+    return g_testFailures ? 1 : 0;
+}
+
+// Context for --selftest without a display server: EGL surfaceless (Mesa) where available.
+// Windows has no EGL; there WGL needs a window, so a hidden GLUT window is used instead.
+static bool createOffscreenContext(int& argc, char** argv) {
+#ifdef _WIN32
     glutInit(&argc, argv);
-    glutInitWindowPosition(0, 0);
-    glutInitWindowSize(600, 600);
-    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE);
-    glutCreateWindow("Con cu baza Bézier");
+    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH);
+    glutCreateWindow("selftest");
+    glutHideWindow();
+    return true;
+#else
+    (void)argc; (void)argv;
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy = getPlatformDisplay
+        ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+        : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)) {
+        std::fprintf(stderr, "selftest: no EGL display\n");
+        return false;
+    }
+    const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    eglChooseConfig(dpy, configAttribs, &config, 1, &configs);
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_NONE };
+    EGLContext ctx = eglCreateContext(dpy, configs ? config : (EGLConfig)nullptr, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        std::fprintf(stderr, "selftest: cannot create a GL 3.3 context (EGL error 0x%x)\n", eglGetError());
+        return false;
+    }
+    return true;
+#endif
+}
 
-    glutDisplayFunc(display);
-    glutIdleFunc(display);
-    glutReshapeFunc(resize);
+int main(int argc, char** argv) {
+    bool selfTest = argc > 1 && std::strcmp(argv[1], "--selftest") == 0;
+    if (selfTest) {
+        if (!createOffscreenContext(argc, argv)) return 1;
+    } else {
+        glutInit(&argc, argv);
+        glutInitWindowPosition(0, 0);
+        glutInitWindowSize(600, 600);
+        glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE);
+        glutCreateWindow("Con cu baza Bézier");
 
-    // Interacțiune
-    glutMouseFunc(OnMouseButton);
-    glutMotionFunc(OnMouseMove);
-    glutSpecialFunc(OnSpecialKey);
-    glutKeyboardFunc(OnKeyboard);
+        glutDisplayFunc(display);
+        glutIdleFunc(display);
+        glutReshapeFunc(resize);
+
+        // Interacțiune
+        glutMouseFunc(OnMouseButton);
+        glutMotionFunc(OnMouseMove);
+        glutSpecialFunc(OnSpecialKey);
+        glutKeyboardFunc(OnKeyboard);
+    }
 
     // Stare OpenGL
     glEnable(GL_DEPTH_TEST);
 
-    // Iluminare existentă (nu modificăm valorile)
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_NORMALIZE);
-    glShadeModel(GL_SMOOTH);
-
-    // Valorile tale curente
-    GLfloat L0_amb[]  = { 0.25f, 0.25f, 0.25f, 1.0f };
-    GLfloat L0_diff[] = { 0.95f, 0.95f, 0.95f, 1.0f };
-    GLfloat L0_spec[] = { 0.85f, 0.85f, 0.85f, 1.0f };
-    glLightfv(GL_LIGHT0, GL_AMBIENT,  L0_amb);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE,  L0_diff);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, L0_spec);
-
-    glEnable(GL_COLOR_MATERIAL);
-    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
-    GLfloat matSpec[] = { 0.5f, 0.5f, 0.5f, 1.0f };
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpec);
-    glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 32.0f);
+#ifdef _WIN32
+    if (glewInit() != GLEW_OK) {
+        std::fprintf(stderr, "glewInit failed\n");
+        return 1;
+    }
+#endif
+    initConeProgram(g_coneProg, linkProgram(kConeVS, kConeFS));
+    const char* const feedback[] = { "vObjPos", "vObjNormal" };
+    initConeProgram(g_coneGpuProg, linkProgram(kConeGpuVS, kConeFS, feedback, 2));
+    initConeProgram(g_sceneProg, linkProgram(kSceneVS, kConeFS), false);   // closed meshes, no interior
+    if (!g_coneProg.id || !g_coneGpuProg.id || !g_sceneProg.id) {
+        std::fprintf(stderr, "shader setup failed\n");
+        return 1;
+    }
+    buildStaticScene(g_scene);
+
+    // Blending only affects the cone's interior wireframe (everything else writes alpha = 1)
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glClearColor(1.f, 1.f, 1.f, 1.f);
 
+    // --selftest [directory with the reference files, default ./selftest]
+    if (selfTest) return runSelfTest(argc > 2 ? argv[2] : "selftest");
+
     glutMainLoop();
     return 0;
 }